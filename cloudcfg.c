@@ -13,6 +13,11 @@
   - Logs as list with autoscroll.
   - ASL Load... to populate token field from a text file.
   - Fix warnings by using APTR for pr_WindowPtr saves/restores.
+  - Mountlist rewrite keeps indentation, comments and CRLF; untouched
+    when the variant is already applied; long lines never mis-matched.
+    File / string handling lives in cloudfile.c (host tests: make test).
+  - PUBLISH switch: public semaphore with mount / registration / variant
+    state and last mount / unmount / apply latency (see cloudstatus.h).
 */
 
 #include <exec/types.h>
@@ -32,9 +37,11 @@
 #include <libraries/asl.h>
 #include <proto/asl.h>
 
+#include "cloudstatus.h"
+#include "cloudfile.h"
+
 #include <string.h>
 #include <stddef.h>
-#include <stdio.h>   /* sprintf for IoErr logging */
 
 struct Library *MUIMasterBase = NULL;
 struct Library *AslBase       = NULL;
@@ -42,9 +49,6 @@ struct Library *AslBase       = NULL;
 /* ASCII helpers */
 #define CH_COLON 58   /* : */
 #define CH_SLASH 47   /* / */
-static int is_ws_or_nl(unsigned char c) {
-    return (c==9 || c==10 || c==13 || c==32);
-}
 
 /* IDs */
 #define ID_QUIT        1000
@@ -64,23 +68,6 @@ static int is_ws_or_nl(unsigned char c) {
 
 #define ID_APPLY_BIN   1301
 
-/* Paths */
-#define PATH_CLOUD_MOUNTLIST   "Devs:Cloud/cloud.mountlist"
-#define PATH_CLOUD_TMP         "Devs:Cloud/.cloud.mountlist.tmp"
-#define PATH_CLOUD_BAK         "Devs:Cloud/cloud.mountlist.bak"
-
-#define PATH_GD_CLIENT_CODE    "Devs:Cloud/google_drive_client_code"
-#define PATH_GD_ACCESS_TOKEN   "Devs:Cloud/google_drive_access_token"
-#define PATH_GD_REFRESH_TOKEN  "Devs:Cloud/google_drive_refresh_token"
-#define PATH_DB_CLIENT_CODE    "Devs:Cloud/dropbox_client_code"
-#define PATH_DB_ACCESS_TOKEN   "Devs:Cloud/dropbox_access_token"
-
-/* Handler filenames */
-#define FN_DB_68K   "dropbox-handler.68k"
-#define FN_DB_102E  "dropbox-handler_102e.68k"
-#define FN_GD_68K   "google-drive-handler.68k"
-#define FN_GD_102E  "google-drive-handler_102e.68k"
-
 /* UI struct */
 struct AppUI {
     Object *app;
@@ -105,10 +92,8 @@ struct AppUI {
 
 /* Prototypes */
 static STRPTR DupString(const char *s);
-static void   LogAppend(const char *s);
 static void   LogLineFlush(void);
 static void   ExecCommand(const char *cmd);
-static LONG   ReadSmallFile(const char *path, char *buf, LONG maxlen);
 static LONG   WriteSmallFile(const char *path, const char *buf);
 static void   EnsureDrawer(const char *fullpath);
 static void   SaveToken(Object *stringobj, const char *filename);
@@ -119,8 +104,6 @@ static void   PurgeTokenGoogle(Object *stringobj);
 static void   PurgeTokenDropbox(Object *stringobj);
 static void   DoMount(const char *volname);
 static void   DoUnmount(const char *volname);
-static void   UpdateMountlistVariant(ULONG variantIndex);
-static ULONG  DetectMountlistVariant(void);
 static void   UpdateTokenMountEnable(struct AppUI *ui);
 static int    IsMounted(const char *assign);
 static void   UpdateStatus(struct AppUI *ui);
@@ -133,6 +116,14 @@ static Object* MakeGroupGoogle(struct AppUI *ui);
 static Object* MakeGroupDropbox(struct AppUI *ui);
 static Object* BuildUI(struct AppUI *ui);
 
+/* Public status block (PUBLISH) */
+static void StatusPublish(void);
+static void StatusUnpublish(void);
+static void StatusSet(ULONG mask, ULONG flags);
+static void StatusSetVariant(ULONG v);
+static void StatusSetLatency(ULONG ms);
+static ULONG StampMs(void);
+
 /* New: handler presence + tab disable */
 static int FileExistsNoReq(const char *path);
 static int HandlersPresentDropbox(void);
@@ -163,7 +154,7 @@ static void LogLineFlush(void) {
     g_LogLen = 0;
 }
 
-static void LogAppend(const char *s) {
+void LogAppend(const char *s) {
     const unsigned char *p;
     if (!s) return;
     p = (const unsigned char*)s;
@@ -185,20 +176,6 @@ static void ExecCommand(const char *cmd) {
     else LogAppend("[Exec] done\n");
 }
 
-static LONG ReadSmallFile(const char *path, char *buf, LONG maxlen) {
-    BPTR fh;
-    LONG n;
-    fh = Open((STRPTR)path, MODE_OLDFILE);
-    n = -1;
-    if (fh) {
-        n = Read(fh, buf, maxlen-1);
-        if (n < 0) n = 0;
-        buf[n] = 0;
-        Close(fh);
-    }
-    return n;
-}
-
 static LONG WriteSmallFile(const char *path, const char *buf) {
     BPTR fh;
     LONG ok;
@@ -244,12 +221,12 @@ static void SaveToken(Object *stringobj, const char *filename) {
 }
 
 static void LoadTokenFile(const char *filename, Object *stringobj) {
-    char buf[512];
+    char buf[TOKEN_BUFSIZE];
     LONG n;
-    int i;
-    n = ReadSmallFile(filename, buf, sizeof(buf));
+    int trunc;
+    n = ReadTokenFile(filename, buf, sizeof(buf), &trunc);
     if (n > 0) {
-        for (i=(int)strlen(buf)-1; i>=0 && is_ws_or_nl((unsigned char)buf[i]); --i) buf[i]=0;
+        if (trunc) LogAppend("[Token] WARNING: default file truncated\n");
         DoMethod(stringobj, MUIM_Set, MUIA_String_Contents, (ULONG)buf);
         LogAppend("[Token] loaded from default file\n");
     }
@@ -263,27 +240,22 @@ static void LoadStringFromFile(Object *stringobj) {
     if (fr) {
         if (AslRequest(fr, NULL)) {
             char path[300];
-            int l, i;
-            BPTR fh;
+            int l, trunc;
             LONG n;
-            char buf[512];
+            char buf[TOKEN_BUFSIZE];
             path[0] = 0;
             if (fr->fr_Drawer) { strncpy(path, (STRPTR)fr->fr_Drawer, sizeof(path)-1); path[sizeof(path)-1] = 0; }
             l = (int)strlen(path);
             if (l>0 && (unsigned char)path[l-1] != CH_COLON && (unsigned char)path[l-1] != CH_SLASH)
                 strncat(path, "/", sizeof(path)-strlen(path)-1);
             if (fr->fr_File) strncat(path, (STRPTR)fr->fr_File, sizeof(path)-strlen(path)-1);
-            fh = Open((STRPTR)path, MODE_OLDFILE);
-            if (fh) {
-                n = Read(fh, buf, sizeof(buf)-1);
-                if (n > 0) {
-                    buf[n] = 0;
-                    for (i=(int)strlen(buf)-1; i>=0 && is_ws_or_nl((unsigned char)buf[i]); --i) buf[i]=0;
-                    DoMethod(stringobj, MUIM_Set, MUIA_String_Contents, (ULONG)buf);
-                    LogAppend("[Token] loaded\n");
-                } else LogAppend("[Token] ERROR: empty file\n");
-                Close(fh);
-            } else LogAppend("[Token] ERROR: open file\n");
+            n = ReadTokenFile(path, buf, sizeof(buf), &trunc);
+            if (n > 0) {
+                if (trunc) LogAppend("[Token] WARNING: file truncated\n");
+                DoMethod(stringobj, MUIM_Set, MUIA_String_Contents, (ULONG)buf);
+                LogAppend("[Token] loaded\n");
+            } else if (n == 0) LogAppend("[Token] ERROR: empty file\n");
+            else LogAppend("[Token] ERROR: open file\n");
         }
         FreeAslRequest(fr);
     } else LogAppend("[Token] ERROR: AllocAslRequest failed\n");
@@ -330,75 +302,6 @@ static void DoUnmount(const char *volname) {
     ExecCommand(cmd);
 }
 
-/* Safe in-place replace of mountlist */
-static void UpdateMountlistVariant(ULONG variantIndex) {
-    const char *db;
-    const char *gd;
-    BPTR in, out;
-    char line[256];
-
-    const char *finalPath = PATH_CLOUD_MOUNTLIST;
-    const char *tmpPath   = PATH_CLOUD_TMP; /* same directory */
-    const char *bakPath   = PATH_CLOUD_BAK;
-
-    if (variantIndex==0) { db = FN_DB_68K;  gd = FN_GD_68K;  }
-    else                  { db = FN_DB_102E; gd = FN_GD_102E; }
-
-    in = Open((STRPTR)finalPath, MODE_OLDFILE);
-    if (!in) { LogAppend("[Mountlist] not found at Devs:Cloud/cloud.mountlist\n"); return; }
-
-    out = Open((STRPTR)tmpPath, MODE_NEWFILE);
-    if (!out) { Close(in); LogAppend("[Mountlist] ERROR: open tmp\n"); return; }
-
-    while (FGets(in, line, sizeof(line))) {
-        if (strstr(line, "Handler = Devs:Cloud/dropbox-handler")) {
-            char outln[128]; outln[0]=0;
-            strcpy(outln, "    Handler = Devs:Cloud/"); strcat(outln, db); strcat(outln, "\n");
-            FWrite(out, (APTR)outln, (LONG)strlen(outln), 1);
-        } else if (strstr(line, "Handler = Devs:Cloud/google-drive-handler")) {
-            char outln[128]; outln[0]=0;
-            strcpy(outln, "    Handler = Devs:Cloud/"); strcat(outln, gd); strcat(outln, "\n");
-            FWrite(out, (APTR)outln, (LONG)strlen(outln), 1);
-        } else {
-            FWrite(out, (APTR)line, (LONG)strlen(line), 1);
-        }
-    }
-    Close(in);
-    Close(out);
-
-    { BPTR lk = Lock((STRPTR)finalPath, ACCESS_READ); if (lk) { UnLock(lk); Rename((STRPTR)finalPath, (STRPTR)bakPath); } }
-
-    if (!Rename((STRPTR)tmpPath, (STRPTR)finalPath)) {
-        LONG err = IoErr();
-        char msg[64];
-        LogAppend("[Mountlist] ERROR: replace (IoErr=");
-        sprintf(msg, "%ld", (long)err);
-        LogAppend(msg);
-        LogAppend(")\n");
-        { BPTR lk = Lock((STRPTR)bakPath, ACCESS_READ); if (lk) { UnLock(lk); Rename((STRPTR)bakPath, (STRPTR)finalPath); } else LogAppend("[Mountlist] WARNING: no backup to restore\n"); }
-        DeleteFile((STRPTR)tmpPath);
-        return;
-    }
-
-    DeleteFile((STRPTR)bakPath);
-    LogAppend("[Mountlist] variant applied\n");
-}
-
-/* Detect current variant from mountlist (0 = 68k, 1 = 102e) */
-static ULONG DetectMountlistVariant(void) {
-    BPTR in;
-    char line[256];
-    ULONG v = 0;
-    in = Open(PATH_CLOUD_MOUNTLIST, MODE_OLDFILE);
-    if (!in) return 0;
-    while (FGets(in, line, sizeof(line))) {
-        if (strstr(line, "Handler = Devs:Cloud/dropbox-handler_102e") ||
-            strstr(line, "Handler = Devs:Cloud/google-drive-handler_102e")) { v = 1; break; }
-    }
-    Close(in);
-    return v;
-}
-
 /* Disable Save/Mount when empty */
 static void UpdateTokenMountEnable(struct AppUI *ui) {
     STRPTR s;
@@ -433,8 +336,12 @@ static int IsMounted(const char *assign) {
 }
 
 static void UpdateStatus(struct AppUI *ui) {
-    DoMethod(ui->gdStatus, MUIM_Set, MUIA_Text_Contents, (ULONG)(IsMounted("GOOGLE:")? "GOOGLE: mounted" : "GOOGLE: not mounted"));
-    DoMethod(ui->dbStatus, MUIM_Set, MUIA_Text_Contents, (ULONG)(IsMounted("DBOX:")?   "DBOX: mounted"   : "DBOX: not mounted"));
+    int gd = IsMounted("GOOGLE:");
+    int db = IsMounted("DBOX:");
+    DoMethod(ui->gdStatus, MUIM_Set, MUIA_Text_Contents, (ULONG)(gd? "GOOGLE: mounted" : "GOOGLE: not mounted"));
+    DoMethod(ui->dbStatus, MUIM_Set, MUIA_Text_Contents, (ULONG)(db? "DBOX: mounted"   : "DBOX: not mounted"));
+    StatusSet(CSF_MOUNT_VALID|CSF_GOOGLE_MOUNTED|CSF_DBOX_MOUNTED,
+              CSF_MOUNT_VALID|(gd? CSF_GOOGLE_MOUNTED:0)|(db? CSF_DBOX_MOUNTED:0));
 }
 
 /* Keyfile detection */
@@ -476,8 +383,79 @@ static int KeyfilePresent(void){
     return found;
 }
 static void UpdateKeyStatus(struct AppUI *ui){
+    int reg = KeyfilePresent();
     DoMethod(ui->keyStatus, MUIM_Set, MUIA_Text_Contents,
-        (ULONG)(KeyfilePresent()? "Registered (read-write)":"Unregistered (read-only)"));
+        (ULONG)(reg? "Registered (read-write)":"Unregistered (read-only)"));
+    StatusSet(CSF_KEY_VALID|CSF_REGISTERED, CSF_KEY_VALID|(reg? CSF_REGISTERED:0));
+}
+
+/* Public status block: other tools read our last known state via
+   FindSemaphore(CLOUDSTATUS_NAME) instead of probing again. */
+static struct CloudStatus *g_Status = NULL;
+
+static void StatusPublish(void){
+    struct CloudStatus *cs;
+    cs = (struct CloudStatus*)AllocVec(sizeof(*cs), MEMF_PUBLIC|MEMF_CLEAR);
+    if(!cs){ LogAppend("[Status] ERROR: no memory\n"); return; }
+    cs->cs_Sem.ss_Link.ln_Name = CLOUDSTATUS_NAME;
+    cs->cs_Version = CLOUDSTATUS_VERSION;
+    Forbid();
+    if(FindSemaphore(CLOUDSTATUS_NAME)){
+        Permit();
+        FreeVec(cs);
+        LogAppend("[Status] already published by another instance\n");
+        return;
+    }
+    AddSemaphore(&cs->cs_Sem);                     /* also initialises it */
+    g_Status = cs;
+    Permit();
+    LogAppend("[Status] published as " CLOUDSTATUS_NAME "\n");
+}
+
+static void StatusUnpublish(void){
+    if(!g_Status) return;
+    Forbid();
+    RemSemaphore(&g_Status->cs_Sem);
+    ObtainSemaphore(&g_Status->cs_Sem);            /* wait out current readers */
+    ReleaseSemaphore(&g_Status->cs_Sem);
+    Permit();
+    FreeVec(g_Status);
+    g_Status = NULL;
+}
+
+/* Setters bump cs_Updates only when a value really changes */
+static void StatusSet(ULONG mask, ULONG flags){
+    ULONG nf;
+    if(!g_Status) return;
+    ObtainSemaphore(&g_Status->cs_Sem);
+    nf = (g_Status->cs_Flags & ~mask) | (flags & mask);
+    if(nf != g_Status->cs_Flags){ g_Status->cs_Flags = nf; g_Status->cs_Updates++; }
+    ReleaseSemaphore(&g_Status->cs_Sem);
+}
+
+static void StatusSetVariant(ULONG v){
+    if(!g_Status) return;
+    ObtainSemaphore(&g_Status->cs_Sem);
+    if(g_Status->cs_Variant != v || !(g_Status->cs_Flags & CSF_VARIANT_VALID)){
+        g_Status->cs_Variant = v;
+        g_Status->cs_Flags |= CSF_VARIANT_VALID;
+        g_Status->cs_Updates++;
+    }
+    ReleaseSemaphore(&g_Status->cs_Sem);
+}
+
+static void StatusSetLatency(ULONG ms){
+    if(!g_Status) return;
+    ObtainSemaphore(&g_Status->cs_Sem);
+    if(g_Status->cs_LastOpMs != ms){ g_Status->cs_LastOpMs = ms; g_Status->cs_Updates++; }
+    ReleaseSemaphore(&g_Status->cs_Sem);
+}
+
+/* Wall clock in ms (DateStamp, 1/50s ticks); only differences are used */
+static ULONG StampMs(void){
+    struct DateStamp ds;
+    DateStamp(&ds);
+    return (ULONG)ds.ds_Days*86400000UL + (ULONG)ds.ds_Minute*60000UL + (ULONG)ds.ds_Tick*(1000UL/TICKS_PER_SECOND);
 }
 
 /* File exists without requesters */
@@ -620,9 +598,22 @@ int main(void) {
     struct AppUI ui;
     ULONG sigs;
     ULONG ret;
+    ULONG t0;
+    LONG  publish;
 
     memset(&ui, 0, sizeof(ui));
     sigs = 0;
+    publish = 0;
+
+    /* Shell only: PUBLISH/S (Workbench start has no pr_CLI) */
+    if (((struct Process*)FindTask(NULL))->pr_CLI) {
+        LONG args[1];
+        struct RDArgs *rda;
+        args[0] = 0;
+        if (!(rda = ReadArgs("PUBLISH/S", args, NULL))) { PrintFault(IoErr(), NULL); return 10; }
+        publish = args[0];
+        FreeArgs(rda);
+    }
 
     MUIMasterBase = OpenLibrary("muimaster.library", 0);
     AslBase       = OpenLibrary("asl.library", 37);
@@ -630,7 +621,9 @@ int main(void) {
 
     if (!BuildUI(&ui)) return 20;
 
-    { ULONG v = DetectMountlistVariant(); DoMethod(ui.cycleVariant, MUIM_Set, MUIA_Cycle_Active, v); }
+    if (publish) StatusPublish();
+
+    { ULONG v = DetectMountlistVariant(); DoMethod(ui.cycleVariant, MUIM_Set, MUIA_Cycle_Active, v); StatusSetVariant(v); }
 
     UpdateHandlersAvailability(&ui);
 
@@ -673,20 +666,24 @@ int main(void) {
             case ID_DB_LOAD:  LoadStringFromFile(ui.dbClient); UpdateTokenMountEnable(&ui); break;
             case ID_GD_PURGE: PurgeTokenGoogle(ui.gdClient);   UpdateTokenMountEnable(&ui); break;
             case ID_DB_PURGE: PurgeTokenDropbox(ui.dbClient);  UpdateTokenMountEnable(&ui); break;
-            case ID_GD_MNT:   DoMount("GOOGLE:"); UpdateStatus(&ui); break;
-            case ID_DB_MNT:   DoMount("DBOX:");   UpdateStatus(&ui); break;
-            case ID_GD_UMNT:  DoUnmount("GOOGLE:"); UpdateStatus(&ui); break;
-            case ID_DB_UMNT:  DoUnmount("DBOX:");   UpdateStatus(&ui); break;
+            /* only mount / unmount / apply are timed for cs_LastOpMs */
+            case ID_GD_MNT:   t0 = StampMs(); DoMount("GOOGLE:");   UpdateStatus(&ui); StatusSetLatency(StampMs() - t0); break;
+            case ID_DB_MNT:   t0 = StampMs(); DoMount("DBOX:");     UpdateStatus(&ui); StatusSetLatency(StampMs() - t0); break;
+            case ID_GD_UMNT:  t0 = StampMs(); DoUnmount("GOOGLE:"); UpdateStatus(&ui); StatusSetLatency(StampMs() - t0); break;
+            case ID_DB_UMNT:  t0 = StampMs(); DoUnmount("DBOX:");   UpdateStatus(&ui); StatusSetLatency(StampMs() - t0); break;
             case ID_APPLY_BIN: {
                 ULONG act = 0;
+                t0 = StampMs();
                 GetAttr(MUIA_Cycle_Active, ui.cycleVariant, (ULONG*)&act);
-                UpdateMountlistVariant(act);
+                if (UpdateMountlistVariant(act)) StatusSetVariant(act);
                 UpdateStatus(&ui);
+                StatusSetLatency(StampMs() - t0);
                 break; }
         }
         if (ret == 0) { if (sigs) Wait(sigs); }
     }
 
+    StatusUnpublish();
     MUI_DisposeObject(ui.app);
     if (AslBase) CloseLibrary(AslBase);
     if (MUIMasterBase) CloseLibrary(MUIMasterBase);
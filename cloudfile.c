@@ -0,0 +1,164 @@
+/*
+ cloudfile.c - mountlist and token file handling for AmigaCloudConfig
+
+ Plain dos.library + string work only; see cloudfile.h.
+*/
+
+#include "cloudfile.h"
+
+#include <string.h>
+#include <stdio.h>   /* sprintf for IoErr logging */
+
+/* ASCII helpers */
+static int is_ws_or_nl(unsigned char c) {
+    return (c==9 || c==10 || c==13 || c==32);
+}
+static void trim_trailing_ws(char *s, int len) {
+    while (len>0 && is_ws_or_nl((unsigned char)s[len-1])) s[--len]=0;
+}
+
+/* Read a token file into buf and trim trailing whitespace / newlines.
+   Returns the token length, -1 when the file cannot be opened. *truncated
+   is set only when the file really holds more than maxlen-1 bytes. */
+LONG ReadTokenFile(const char *path, char *buf, LONG maxlen, int *truncated) {
+    BPTR fh;
+    LONG n;
+    char extra;
+    if (truncated) *truncated = 0;
+    fh = Open((STRPTR)path, MODE_OLDFILE);
+    if (!fh) { buf[0] = 0; return -1; }
+    n = Read(fh, buf, maxlen-1);
+    if (n < 0) n = 0;
+    buf[n] = 0;
+    if (n == maxlen-1 && truncated && Read(fh, &extra, 1) == 1) *truncated = 1;
+    Close(fh);
+    trim_trailing_ws(buf, (int)strlen(buf));
+    return (LONG)strlen(buf);
+}
+
+/* Offset of the handler filename when line is "...Handler = Devs:Cloud/<stem>...",
+   else -1. *nameLen gets the filename length (up to whitespace / line end). */
+static int FindHandlerName(const char *line, const char *stem, int *nameLen) {
+    const char *p;
+    int off, n;
+    p = strstr(line, ML_HANDLER_KEY);
+    if (!p) return -1;
+    off = (int)(p - line) + (int)(sizeof(ML_HANDLER_KEY)-1);
+    if (strncmp(line+off, stem, strlen(stem)) != 0) return -1;
+    for (n=0; line[off+n] && !is_ws_or_nl((unsigned char)line[off+n]); ++n) ;
+    if (nameLen) *nameLen = n;
+    return off;
+}
+
+/* Safe in-place replace of mountlist (1 = mountlist now uses the variant) */
+int UpdateMountlistVariant(ULONG variantIndex) {
+    const char *db;
+    const char *gd;
+    BPTR in, out;
+    char line[256];
+    char outln[sizeof(line)+32];   /* prefix + longest FN_* + suffix */
+    int  bol, len, off, nl;
+    int  matched, changed, skipped;
+    LONG total, pos;
+
+    const char *finalPath = PATH_CLOUD_MOUNTLIST;
+    const char *tmpPath   = PATH_CLOUD_TMP; /* same directory */
+    const char *bakPath   = PATH_CLOUD_BAK;
+
+    if (variantIndex==0) { db = FN_DB_68K;  gd = FN_GD_68K;  }
+    else                  { db = FN_DB_102E; gd = FN_GD_102E; }
+
+    in = Open((STRPTR)finalPath, MODE_OLDFILE);
+    if (!in) { LogAppend("[Mountlist] not found at Devs:Cloud/cloud.mountlist\n"); return 0; }
+
+    out = Open((STRPTR)tmpPath, MODE_NEWFILE);
+    if (!out) { Close(in); LogAppend("[Mountlist] ERROR: open tmp\n"); return 0; }
+
+    /* FGets splits lines longer than the buffer: only a chunk that starts a
+       line is matched, and only rewritten when the filename ends inside it.
+       Everything around the filename (indent, comments, CR) is kept as-is.
+       A NUL byte would cut a chunk short; total vs. file position catches it. */
+    bol = 1; matched = 0; changed = 0; skipped = 0; total = 0;
+    while (FGets(in, line, sizeof(line))) {
+        const char *fn = NULL;
+        len = (int)strlen(line);
+        total += len;
+        off = -1; nl = 0;
+        if (bol) {
+            if ((off = FindHandlerName(line, ML_STEM_DB, &nl)) >= 0) fn = db;
+            else if ((off = FindHandlerName(line, ML_STEM_GD, &nl)) >= 0) fn = gd;
+            /* both variants must fit the first chunk, or we could not revert */
+            if (fn && ((off+nl == len && len == (int)sizeof(line)-1) ||
+                       off + (int)strlen(fn == db ? FN_DB_102E : FN_GD_102E) >= (int)sizeof(line)-1)) {
+                LogAppend("[Mountlist] WARNING: handler line too long\n");
+                fn = NULL;
+                skipped++;
+            }
+            if (fn) matched++;
+        }
+        if (fn && (nl != (int)strlen(fn) || strncmp(line+off, fn, nl) != 0)) {
+            memcpy(outln, line, off);
+            strcpy(outln+off, fn);
+            strcat(outln, line+off+nl);
+            FWrite(out, (APTR)outln, (LONG)strlen(outln), 1);
+            changed++;
+        } else {
+            FWrite(out, (APTR)line, (LONG)len, 1);
+        }
+        bol = (len > 0 && line[len-1] == 10);
+    }
+    pos = Seek(in, 0, OFFSET_CURRENT);
+    Close(in);
+    Close(out);
+
+    /* Never publish a half-applied or unverifiable variant */
+    if (pos != total || skipped || !matched || !changed) {
+        DeleteFile((STRPTR)tmpPath);
+        if (pos != total)  LogAppend("[Mountlist] ERROR: NUL byte in mountlist, left unchanged\n");
+        else if (skipped)  LogAppend("[Mountlist] ERROR: handler line(s) too long, left unchanged\n");
+        else if (!matched) LogAppend("[Mountlist] ERROR: no Handler line found, left unchanged\n");
+        else               LogAppend("[Mountlist] variant already applied\n");
+        return (pos == total && !skipped && matched) ? 1 : 0;
+    }
+
+    { BPTR lk = Lock((STRPTR)finalPath, ACCESS_READ); if (lk) { UnLock(lk); Rename((STRPTR)finalPath, (STRPTR)bakPath); } }
+
+    if (!Rename((STRPTR)tmpPath, (STRPTR)finalPath)) {
+        LONG err = IoErr();
+        char msg[64];
+        LogAppend("[Mountlist] ERROR: replace (IoErr=");
+        sprintf(msg, "%ld", (long)err);
+        LogAppend(msg);
+        LogAppend(")\n");
+        { BPTR lk = Lock((STRPTR)bakPath, ACCESS_READ); if (lk) { UnLock(lk); Rename((STRPTR)bakPath, (STRPTR)finalPath); } else LogAppend("[Mountlist] WARNING: no backup to restore\n"); }
+        DeleteFile((STRPTR)tmpPath);
+        return 0;
+    }
+
+    DeleteFile((STRPTR)bakPath);
+    LogAppend("[Mountlist] variant applied\n");
+    return 1;
+}
+
+/* Detect current variant from mountlist (0 = 68k, 1 = 102e) */
+ULONG DetectMountlistVariant(void) {
+    BPTR in;
+    char line[256];
+    ULONG v = 0;
+    int bol, len, off;
+    in = Open(PATH_CLOUD_MOUNTLIST, MODE_OLDFILE);
+    if (!in) return 0;
+    bol = 1;
+    while (FGets(in, line, sizeof(line))) {
+        len = (int)strlen(line);
+        if (bol) {
+            if ((off = FindHandlerName(line, ML_STEM_DB, NULL)) >= 0 &&
+                !strncmp(line+off+sizeof(ML_STEM_DB)-1, ML_SUFFIX_102E, sizeof(ML_SUFFIX_102E)-1)) { v = 1; break; }
+            if ((off = FindHandlerName(line, ML_STEM_GD, NULL)) >= 0 &&
+                !strncmp(line+off+sizeof(ML_STEM_GD)-1, ML_SUFFIX_102E, sizeof(ML_SUFFIX_102E)-1)) { v = 1; break; }
+        }
+        bol = (len > 0 && line[len-1] == 10);
+    }
+    Close(in);
+    return v;
+}
@@ -0,0 +1,51 @@
+/*
+ cloudfile.h - mountlist and token file handling (no MUI)
+
+ Kept apart from the GUI so test/ can build it on the host against a
+ small stdio shim (make test).
+*/
+
+#ifndef CLOUDFILE_H
+#define CLOUDFILE_H
+
+#ifdef CLOUD_HOST_TEST
+#include "hostshim.h"
+#else
+#include <exec/types.h>
+#include <proto/dos.h>
+#endif
+
+/* Paths */
+#define PATH_CLOUD_MOUNTLIST   "Devs:Cloud/cloud.mountlist"
+#define PATH_CLOUD_TMP         "Devs:Cloud/.cloud.mountlist.tmp"
+#define PATH_CLOUD_BAK         "Devs:Cloud/cloud.mountlist.bak"
+
+#define PATH_GD_CLIENT_CODE    "Devs:Cloud/google_drive_client_code"
+#define PATH_GD_ACCESS_TOKEN   "Devs:Cloud/google_drive_access_token"
+#define PATH_GD_REFRESH_TOKEN  "Devs:Cloud/google_drive_refresh_token"
+#define PATH_DB_CLIENT_CODE    "Devs:Cloud/dropbox_client_code"
+#define PATH_DB_ACCESS_TOKEN   "Devs:Cloud/dropbox_access_token"
+
+/* Handler filenames */
+#define FN_DB_68K   "dropbox-handler.68k"
+#define FN_DB_102E  "dropbox-handler_102e.68k"
+#define FN_GD_68K   "google-drive-handler.68k"
+#define FN_GD_102E  "google-drive-handler_102e.68k"
+
+/* Mountlist handler line: KEY followed by one of the STEMs */
+#define ML_HANDLER_KEY  "Handler = Devs:Cloud/"
+#define ML_STEM_DB      "dropbox-handler"
+#define ML_STEM_GD      "google-drive-handler"
+#define ML_SUFFIX_102E  "_102e"
+
+/* Token read buffer (token + trailing newline fits easily) */
+#define TOKEN_BUFSIZE   512
+
+/* Provided by the caller (cloudcfg.c: log list, test/: capture) */
+void  LogAppend(const char *s);
+
+LONG  ReadTokenFile(const char *path, char *buf, LONG maxlen, int *truncated);
+int   UpdateMountlistVariant(ULONG variantIndex);
+ULONG DetectMountlistVariant(void);
+
+#endif /* CLOUDFILE_H */
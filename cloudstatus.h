@@ -0,0 +1,50 @@
+/*
+ cloudstatus.h - public status block published by AmigaCloudConfig PUBLISH
+
+ When started from the Shell with the PUBLISH switch, AmigaCloudConfig adds a
+ named public semaphore holding its last known cloud state. Fields are updated
+ whenever the tool runs its own checks, so clients read them without any
+ Lock / directory scan / handler traffic:
+
+    struct CloudStatus *cs, copy;
+    Forbid();
+    if ((cs = (struct CloudStatus*)FindSemaphore(CLOUDSTATUS_NAME))) {
+        ObtainSemaphoreShared(&cs->cs_Sem);
+        copy = *cs;
+        ReleaseSemaphore(&cs->cs_Sem);
+    }
+    Permit();
+
+ Do not keep the pointer past Permit(): the block goes away when the tool quits.
+*/
+
+#ifndef CLOUDSTATUS_H
+#define CLOUDSTATUS_H
+
+#include <exec/types.h>
+#include <exec/semaphores.h>
+
+#define CLOUDSTATUS_NAME     "AmigaCloudConfig.status"
+#define CLOUDSTATUS_VERSION  1
+
+/* cs_Flags: a state bit is only meaningful when its _VALID bit is set */
+#define CSF_MOUNT_VALID      (1UL<<0)   /* GOOGLE:/DBOX: probed at least once */
+#define CSF_GOOGLE_MOUNTED   (1UL<<1)
+#define CSF_DBOX_MOUNTED     (1UL<<2)
+#define CSF_KEY_VALID        (1UL<<3)   /* keyfile scan done */
+#define CSF_REGISTERED       (1UL<<4)
+#define CSF_VARIANT_VALID    (1UL<<5)   /* cs_Variant read from mountlist */
+
+/* Offsets: cs_Sem 0 (46 bytes), cs_Version 46, cs_Flags 48, cs_Variant 52,
+   cs_LastOpMs 56, cs_Updates 60; sizeof 64. All ULONGs are 4-byte aligned. */
+struct CloudStatus {
+    struct SignalSemaphore cs_Sem;      /* ss_Link.ln_Name = CLOUDSTATUS_NAME */
+    UWORD  cs_Version;                  /* CLOUDSTATUS_VERSION */
+    ULONG  cs_Flags;                    /* CSF_* */
+    ULONG  cs_Variant;                  /* 0 = 68k, 1 = 102e */
+    ULONG  cs_LastOpMs;                 /* last Mount / Unmount / Apply incl. its status probe,
+                                           ms (1/50s resolution, so 0 = under one tick or none yet) */
+    ULONG  cs_Updates;                  /* bumped whenever any field changes */
+};
+
+#endif /* CLOUDSTATUS_H */
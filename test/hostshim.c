@@ -0,0 +1,86 @@
+/*
+ hostshim.c - stdio implementation of the dos.library calls in hostshim.h
+*/
+
+#include "hostshim.h"
+
+#include <string.h>
+
+static char g_Root[256] = ".";
+static LONG g_IoErr = 0;
+
+void host_SetRoot(const char *dir) {
+    strncpy(g_Root, dir, sizeof(g_Root)-1);
+    g_Root[sizeof(g_Root)-1] = 0;
+}
+
+static const char *MapPath(const char *name, char *out, size_t outsz) {
+    static const char prefix[] = "Devs:Cloud/";
+    if (strncmp(name, prefix, sizeof(prefix)-1) == 0) {
+        snprintf(out, outsz, "%s/%s", g_Root, name+sizeof(prefix)-1);
+        return out;
+    }
+    return name;
+}
+
+BPTR Open(STRPTR name, LONG mode) {
+    char p[512];
+    BPTR fh = fopen(MapPath(name, p, sizeof(p)), mode == MODE_NEWFILE ? "wb" : "rb");
+    g_IoErr = fh ? 0 : ERROR_OBJECT_NOT_FOUND;
+    return fh;
+}
+
+LONG Close(BPTR fh) {
+    return fclose(fh) == 0;
+}
+
+LONG Read(BPTR fh, APTR buf, LONG len) {
+    size_t n = fread(buf, 1, (size_t)len, fh);
+    return ferror(fh) ? -1 : (LONG)n;
+}
+
+STRPTR FGets(BPTR fh, STRPTR buf, ULONG len) {
+    return fgets(buf, (int)len, fh);
+}
+
+/* Returns the previous position, like dos.library */
+LONG Seek(BPTR fh, LONG pos, LONG mode) {
+    long old = ftell(fh);
+    int whence = mode == OFFSET_BEGINNING ? SEEK_SET : mode == OFFSET_END ? SEEK_END : SEEK_CUR;
+    if (old < 0 || fseek(fh, pos, whence) != 0) { g_IoErr = ERROR_SEEK_ERROR; return -1; }
+    return (LONG)old;
+}
+
+LONG FWrite(BPTR fh, APTR buf, ULONG blocklen, ULONG blocks) {
+    return (LONG)fwrite(buf, blocklen, blocks, fh);
+}
+
+BPTR Lock(STRPTR name, LONG mode) {
+    (void)mode;
+    return Open(name, MODE_OLDFILE);
+}
+
+void UnLock(BPTR lk) {
+    if (lk) fclose(lk);
+}
+
+/* AmigaDOS Rename() refuses to overwrite an existing object */
+LONG Rename(STRPTR oldname, STRPTR newname) {
+    char po[512], pn[512];
+    FILE *f;
+    const char *o = MapPath(oldname, po, sizeof(po));
+    const char *n = MapPath(newname, pn, sizeof(pn));
+    if ((f = fopen(n, "rb"))) { fclose(f); g_IoErr = ERROR_OBJECT_EXISTS; return 0; }
+    if (rename(o, n) != 0) { g_IoErr = ERROR_OBJECT_NOT_FOUND; return 0; }
+    g_IoErr = 0;
+    return 1;
+}
+
+LONG DeleteFile(STRPTR name) {
+    char p[512];
+    return remove(MapPath(name, p, sizeof(p))) == 0;
+}
+
+LONG IoErr(void) {
+    return g_IoErr;
+}
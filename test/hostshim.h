@@ -0,0 +1,46 @@
+/*
+ hostshim.h - minimal dos.library stand-in over stdio for host tests
+
+ "Devs:Cloud/..." paths are mapped into the directory set with
+ host_SetRoot(); every other path is used as-is.
+*/
+
+#ifndef HOSTSHIM_H
+#define HOSTSHIM_H
+
+#include <stdio.h>
+
+typedef unsigned long  ULONG;
+typedef long           LONG;
+typedef unsigned short UWORD;
+typedef void          *APTR;
+typedef char          *STRPTR;
+typedef FILE          *BPTR;
+
+#define MODE_OLDFILE  1005
+#define MODE_NEWFILE  1006
+#define ACCESS_READ   -2
+
+#define OFFSET_BEGINNING  -1
+#define OFFSET_CURRENT     0
+#define OFFSET_END         1
+
+#define ERROR_OBJECT_EXISTS     203
+#define ERROR_OBJECT_NOT_FOUND  205
+#define ERROR_SEEK_ERROR        219
+
+void  host_SetRoot(const char *dir);
+
+BPTR  Open(STRPTR name, LONG mode);
+LONG  Close(BPTR fh);
+LONG  Read(BPTR fh, APTR buf, LONG len);
+STRPTR FGets(BPTR fh, STRPTR buf, ULONG len);
+LONG  Seek(BPTR fh, LONG pos, LONG mode);
+LONG  FWrite(BPTR fh, APTR buf, ULONG blocklen, ULONG blocks);
+BPTR  Lock(STRPTR name, LONG mode);
+void  UnLock(BPTR lk);
+LONG  Rename(STRPTR oldname, STRPTR newname);
+LONG  DeleteFile(STRPTR name);
+LONG  IoErr(void);
+
+#endif /* HOSTSHIM_H */
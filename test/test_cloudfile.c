@@ -0,0 +1,455 @@
+/*
+ test_cloudfile.c - host tests and throughput figures for cloudfile.c
+
+ Builds generated mountlists and token files (thousands of entries, long
+ lines, CRLF, NUL bytes, missing handlers, random noise) in a temp directory
+ mapped to Devs:Cloud/, checks rewrites byte for byte and checks time per MB
+ against a plain copy measured in the same run.
+
+ make test
+*/
+
+#include "cloudfile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Log capture */
+static char g_Log[4096];
+
+void LogAppend(const char *s) {
+    size_t l = strlen(g_Log);
+    strncat(g_Log, s, sizeof(g_Log)-l-1);
+}
+
+static int g_Fails = 0;
+static int g_Checks = 0;
+
+#define CHECK(cond, what) do { g_Checks++; if (!(cond)) { g_Fails++; \
+    fprintf(stderr, "FAIL %s:%d: %s\n  log: %s\n", __FILE__, __LINE__, what, g_Log); } } while (0)
+
+static char g_Dir[256];
+static char g_MlPath[300];
+
+/* Growable byte buffer */
+struct Buf { char *p; size_t len, cap; };
+
+static void BufAdd(struct Buf *b, const char *s, size_t n) {
+    if (b->len + n + 1 > b->cap) {
+        b->cap = (b->len + n + 1) * 2;
+        b->p = (char*)realloc(b->p, b->cap);
+    }
+    memcpy(b->p + b->len, s, n);
+    b->len += n;
+    b->p[b->len] = 0;
+}
+static void BufStr(struct Buf *b, const char *s) { BufAdd(b, s, strlen(s)); }
+static void BufFree(struct Buf *b) { free(b->p); b->p = NULL; b->len = b->cap = 0; }
+
+static void WriteHostFile(const char *path, const char *data, size_t len) {
+    FILE *f = fopen(path, "wb");
+    if (!f || fwrite(data, 1, len, f) != len) { perror(path); exit(2); }
+    fclose(f);
+}
+
+static char *ReadHostFile(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    char *p;
+    long n;
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END); n = ftell(f); fseek(f, 0, SEEK_SET);
+    p = (char*)malloc((size_t)n + 1);
+    if (fread(p, 1, (size_t)n, f) != (size_t)n) { perror(path); exit(2); }
+    p[n] = 0;
+    fclose(f);
+    *len = (size_t)n;
+    return p;
+}
+
+static void SetMountlist(const struct Buf *b) { WriteHostFile(g_MlPath, b->p, b->len); }
+
+static int MountlistIs(const char *data, size_t len) {
+    size_t n;
+    char *p = ReadHostFile(g_MlPath, &n);
+    int ok = p && n == len && memcmp(p, data, len) == 0;
+    free(p);
+    return ok;
+}
+
+/* No tmp / bak left behind in Devs:Cloud/ */
+static int NoLeftovers(void) {
+    char p[300];
+    snprintf(p, sizeof(p), "%s/.cloud.mountlist.tmp", g_Dir);
+    if (access(p, F_OK) == 0) return 0;
+    snprintf(p, sizeof(p), "%s/cloud.mountlist.bak", g_Dir);
+    return access(p, F_OK) != 0;
+}
+
+static int Apply(ULONG v) { g_Log[0] = 0; return UpdateMountlistVariant(v); }
+
+/* One mountlist entry; variant selects the handler names, eol "\n" or "\r\n" */
+static void AddEntry(struct Buf *b, int i, int variant, const char *eol) {
+    char l[128];
+    int db = (i & 1);
+    snprintf(l, sizeof(l), "%s%d:%s", db ? "DBOX" : "GOOGLE", i, eol); BufStr(b, l);
+    snprintf(l, sizeof(l), "    Handler = Devs:Cloud/%s%s", db ? (variant ? FN_DB_102E : FN_DB_68K)
+                                                           : (variant ? FN_GD_102E : FN_GD_68K), eol); BufStr(b, l);
+    snprintf(l, sizeof(l), "    Stacksize = 16384%s    Priority = 5%s    GlobVec = -1%s#%s", eol, eol, eol, eol); BufStr(b, l);
+}
+
+static void MakeMountlist(struct Buf *b, int entries, int variant, const char *eol) {
+    int i;
+    b->len = 0;
+    BufStr(b, "/* cloud.mountlist */"); BufStr(b, eol);
+    for (i = 0; i < entries; ++i) AddEntry(b, i, variant, eol);
+}
+
+/* Apply 1 then 0 to a 68k list: expect the 102e twin, then the original back */
+static void RoundTrip(const char *name, int entries, const char *eol) {
+    struct Buf m68 = {0}, m102 = {0};
+    char what[128];
+    MakeMountlist(&m68, entries, 0, eol);
+    MakeMountlist(&m102, entries, 1, eol);
+    SetMountlist(&m68);
+
+    snprintf(what, sizeof(what), "%s: same variant is a no-op", name);
+    CHECK(Apply(0) == 1 && strstr(g_Log, "already applied") && MountlistIs(m68.p, m68.len), what);
+    snprintf(what, sizeof(what), "%s: detect 68k", name);
+    CHECK(DetectMountlistVariant() == 0, what);
+    snprintf(what, sizeof(what), "%s: apply 102e", name);
+    CHECK(Apply(1) == 1 && MountlistIs(m102.p, m102.len) && NoLeftovers(), what);
+    snprintf(what, sizeof(what), "%s: detect 102e", name);
+    CHECK(DetectMountlistVariant() == 1, what);
+    snprintf(what, sizeof(what), "%s: back to 68k is byte-identical", name);
+    CHECK(Apply(0) == 1 && MountlistIs(m68.p, m68.len) && NoLeftovers(), what);
+
+    BufFree(&m68); BufFree(&m102);
+}
+
+static void TestPreserveLayout(void) {
+    static const char in[]  = "DBOX:\r\n\tHandler = Devs:Cloud/dropbox-handler.68k ; comment\r\n"
+                              "GOOGLE:\n  Handler = Devs:Cloud/google-drive-handler.68k\n#";
+    static const char out[] = "DBOX:\r\n\tHandler = Devs:Cloud/dropbox-handler_102e.68k ; comment\r\n"
+                              "GOOGLE:\n  Handler = Devs:Cloud/google-drive-handler_102e.68k\n#";
+    WriteHostFile(g_MlPath, in, sizeof(in)-1);
+    CHECK(Apply(1) == 1 && MountlistIs(out, sizeof(out)-1), "indent, comment, CRLF and missing final LF kept");
+    CHECK(Apply(0) == 1 && MountlistIs(in, sizeof(in)-1), "layout round trip");
+
+    /* Last line without LF, ending right on the filename */
+    {
+        static const char e_in[]  = "DBOX:\n Handler = Devs:Cloud/dropbox-handler.68k";
+        static const char e_out[] = "DBOX:\n Handler = Devs:Cloud/dropbox-handler_102e.68k";
+        WriteHostFile(g_MlPath, e_in, sizeof(e_in)-1);
+        CHECK(Apply(1) == 1 && MountlistIs(e_out, sizeof(e_out)-1), "handler on last line without LF");
+    }
+}
+
+static void TestLongLines(void) {
+    struct Buf b = {0};
+    char pad[2048];
+
+    /* Handler text inside the continuation of a long comment: never touched */
+    memset(pad, 'x', sizeof(pad)); pad[sizeof(pad)-1] = 0;
+    BufStr(&b, "; "); BufAdd(&b, pad, 300);
+    BufStr(&b, " Handler = Devs:Cloud/dropbox-handler.68k\n");
+    BufStr(&b, "DBOX:\n    Handler = Devs:Cloud/dropbox-handler.68k\n");
+    {
+        struct Buf want = {0};
+        BufStr(&want, "; "); BufAdd(&want, pad, 300);
+        BufStr(&want, " Handler = Devs:Cloud/dropbox-handler.68k\n");
+        BufStr(&want, "DBOX:\n    Handler = Devs:Cloud/dropbox-handler_102e.68k\n");
+        SetMountlist(&b);
+        CHECK(Apply(1) == 1 && MountlistIs(want.p, want.len), "long comment continuation left alone");
+        CHECK(DetectMountlistVariant() == 1, "detect ignores continuation chunks");
+        BufFree(&want);
+    }
+
+    /* Handler line whose filename runs past the FGets buffer: refused, file untouched */
+    b.len = 0;
+    BufStr(&b, "DBOX:\n    Handler = Devs:Cloud/dropbox-handler.68k\n");
+    BufStr(&b, "GOOGLE:\n"); BufAdd(&b, "                                        ", 40);
+    BufStr(&b, "Handler = Devs:Cloud/google-drive-handler"); BufAdd(&b, pad, 400); BufStr(&b, "\n");
+    SetMountlist(&b);
+    CHECK(Apply(1) == 0 && strstr(g_Log, "too long") && MountlistIs(b.p, b.len) && NoLeftovers(),
+          "overlong handler line aborts without partial rewrite");
+
+    /* 68k name fits the buffer but the 102e one would not: refused, so it stays revertible */
+    b.len = 0;
+    BufStr(&b, "DBOX:\n    Handler = Devs:Cloud/dropbox-handler.68k\n");
+    memset(pad, ' ', 205); pad[205] = 0; BufStr(&b, pad);
+    BufStr(&b, "Handler = Devs:Cloud/google-drive-handler.68k\n");
+    SetMountlist(&b);
+    CHECK(Apply(1) == 0 && strstr(g_Log, "too long") && MountlistIs(b.p, b.len) && NoLeftovers(),
+          "handler line with no room for the 102e name refused");
+    memset(pad, 'x', sizeof(pad)); pad[sizeof(pad)-1] = 0;
+
+    /* Long non-handler lines of every length around the buffer size */
+    {
+        int n;
+        struct Buf want = {0};
+        b.len = 0;
+        for (n = 250; n < 520; ++n) { BufAdd(&b, pad, (size_t)n); BufStr(&b, n & 1 ? "\r\n" : "\n"); }
+        want.len = 0; BufAdd(&want, b.p, b.len);
+        BufStr(&b,    "DBOX:\n Handler = Devs:Cloud/dropbox-handler.68k\n");
+        BufStr(&want, "DBOX:\n Handler = Devs:Cloud/dropbox-handler_102e.68k\n");
+        SetMountlist(&b);
+        CHECK(Apply(1) == 1 && MountlistIs(want.p, want.len), "lines of 250..519 bytes copied verbatim");
+        BufFree(&want);
+    }
+    BufFree(&b);
+}
+
+static void TestMissingHandlers(void) {
+    struct Buf b = {0};
+    int i;
+    char l[64];
+    for (i = 0; i < 2000; ++i) { snprintf(l, sizeof(l), "DEV%d:\n    Stacksize = 4096\n#\n", i); BufStr(&b, l); }
+    SetMountlist(&b);
+    CHECK(Apply(1) == 0 && strstr(g_Log, "no Handler line") && MountlistIs(b.p, b.len) && NoLeftovers(),
+          "no handler lines: refused, not reported as applied");
+    CHECK(DetectMountlistVariant() == 0, "detect with no handler lines");
+
+    /* Foreign handlers only */
+    b.len = 0;
+    BufStr(&b, "FOO:\n    Handler = Devs:Cloud/other-handler\n    Handler = L:fat95\n");
+    SetMountlist(&b);
+    CHECK(Apply(0) == 0 && MountlistIs(b.p, b.len), "foreign handlers untouched");
+
+    /* Empty file and no file */
+    WriteHostFile(g_MlPath, "", 0);
+    CHECK(Apply(1) == 0 && MountlistIs("", 0), "empty mountlist");
+    remove(g_MlPath);
+    CHECK(Apply(1) == 0 && strstr(g_Log, "not found"), "missing mountlist");
+    CHECK(DetectMountlistVariant() == 0, "detect with missing mountlist");
+
+    /* Embedded NUL: FGets cannot carry it, so refuse rather than drop bytes */
+    b.len = 0;
+    BufAdd(&b, "a\0bcdef\n", 8);
+    BufStr(&b, "DBOX:\n    Handler = Devs:Cloud/dropbox-handler.68k\n");
+    SetMountlist(&b);
+    CHECK(Apply(1) == 0 && strstr(g_Log, "NUL byte") && MountlistIs(b.p, b.len) && NoLeftovers(),
+          "NUL byte: refused, file unchanged");
+    BufFree(&b);
+}
+
+/* Random noise mixed with canonical 68k entries: 1 then 0 must restore it */
+static ULONG g_Seed = 12345;
+static ULONG Rnd(void) { g_Seed = g_Seed * 1103515245UL + 12345UL; return (g_Seed >> 16) & 0x7fff; }
+
+static void TestFuzz(int rounds) {
+    struct Buf b = {0};
+    int r, i, k;
+    char junk[700];
+    for (r = 0; r < rounds; ++r) {
+        b.len = 0;
+        for (i = (int)(Rnd() % 200); i >= 0; --i) {
+            switch (Rnd() % 6) {
+            case 0: AddEntry(&b, (int)Rnd(), 0, Rnd() & 1 ? "\r\n" : "\n"); break;
+            case 1: /* random printable line, may embed a handler string deep inside */
+                k = (int)(Rnd() % (sizeof(junk)-80));
+                memset(junk, 'a' + (int)(Rnd() % 26), (size_t)k); junk[k] = 0;
+                BufStr(&b, junk);
+                if (Rnd() & 1) BufStr(&b, " Handler = Devs:Cloud/google-drive-handler.68k");
+                BufStr(&b, "\n");
+                break;
+            case 2: BufStr(&b, "\n"); break;
+            case 3: BufStr(&b, "\t\t Handler = Devs:Cloud/dropbox-handler.68k \t; x\r\n"); break;
+            case 4: /* raw bytes; NUL only now and then so most rounds still apply */
+                k = (int)(Rnd() % 64) + 1;
+                for (; k; --k) { char c = (char)(Rnd() % 256); if (!c && Rnd() % 8) c = 1; BufAdd(&b, &c, 1); }
+                break;
+            default: BufStr(&b, "    Handler = L:other\n"); break;
+            }
+        }
+        /* guarantee at least one of ours at line start */
+        BufStr(&b, "\nDBOX:\n Handler = Devs:Cloud/dropbox-handler.68k\n");
+        SetMountlist(&b);
+        if (memchr(b.p, 0, b.len)) {
+            if (Apply(1) != 0 || !strstr(g_Log, "NUL byte") || !MountlistIs(b.p, b.len) || !NoLeftovers())
+                { CHECK(0, "fuzz: NUL byte must leave the file alone"); break; }
+            g_Checks++;
+            continue;
+        }
+        if (Apply(1) != 1) {
+            /* a filename crossing the FGets buffer must leave the file alone */
+            if (strstr(g_Log, "too long") && MountlistIs(b.p, b.len) && NoLeftovers()) { g_Checks++; continue; }
+            CHECK(0, "fuzz: apply 102e"); break;
+        }
+        if (DetectMountlistVariant() != 1)         { CHECK(0, "fuzz: detect 102e"); break; }
+        if (Apply(1) != 1 || !strstr(g_Log, "already applied")) { CHECK(0, "fuzz: re-apply is a no-op"); break; }
+        if (Apply(0) != 1 || !MountlistIs(b.p, b.len)) { CHECK(0, "fuzz: round trip byte-identical"); break; }
+        if (!NoLeftovers())                        { CHECK(0, "fuzz: leftovers"); break; }
+        g_Checks++;
+    }
+    BufFree(&b);
+}
+
+static void TokenCase(const char *data, size_t len, LONG wantLen, int wantTrunc, const char *what) {
+    char p[300], buf[TOKEN_BUFSIZE];
+    int trunc = -1;
+    LONG n;
+    snprintf(p, sizeof(p), "%s/token", g_Dir);
+    WriteHostFile(p, data, len);
+    n = ReadTokenFile(p, buf, sizeof(buf), &trunc);
+    CHECK(n == wantLen && trunc == wantTrunc && (LONG)strlen(buf) == n, what);
+}
+
+static void TestTokens(void) {
+    char big[1024];
+    memset(big, 'T', sizeof(big));
+
+    TokenCase("abc\r\n", 5, 3, 0, "token: CRLF trimmed");
+    TokenCase("abc \t \n\n\r", 9, 3, 0, "token: trailing blanks trimmed");
+    TokenCase("  abc", 5, 5, 0, "token: leading blanks kept");
+    TokenCase("", 0, 0, 0, "token: empty file");
+    TokenCase(" \r\n\t", 4, 0, 0, "token: whitespace only");
+    TokenCase(big, TOKEN_BUFSIZE-1, TOKEN_BUFSIZE-1, 0, "token: exactly 511 bytes is not truncated");
+    TokenCase(big, TOKEN_BUFSIZE, TOKEN_BUFSIZE-1, 1, "token: 512 bytes is truncated");
+    TokenCase(big, sizeof(big), TOKEN_BUFSIZE-1, 1, "token: 1024 bytes is truncated");
+    {
+        char tmp[TOKEN_BUFSIZE];
+        memcpy(tmp, big, sizeof(tmp));
+        tmp[TOKEN_BUFSIZE-2] = '\n'; /* token + LF filling the buffer exactly */
+        TokenCase(tmp, TOKEN_BUFSIZE-1, TOKEN_BUFSIZE-2, 0, "token: 510 + LF");
+    }
+    {
+        char p[300], buf[TOKEN_BUFSIZE];
+        snprintf(p, sizeof(p), "%s/no-such-token", g_Dir);
+        CHECK(ReadTokenFile(p, buf, sizeof(buf), NULL) == -1 && buf[0] == 0, "token: missing file");
+    }
+}
+
+/* Random tokens around TOKEN_BUFSIZE with mixed trailing whitespace,
+   checked against a straightforward model of truncate-then-trim */
+static void TestTokenFuzz(int rounds) {
+    static const char ws[] = " \t\r\n";
+    char data[TOKEN_BUFSIZE+128], want[TOKEN_BUFSIZE], buf[TOKEN_BUFSIZE], p[300];
+    int r, i, body, tail, len, wl, trunc;
+    LONG n;
+    snprintf(p, sizeof(p), "%s/token", g_Dir);
+    for (r = 0; r < rounds; ++r) {
+        body = (int)(Rnd() % 8 == 0 ? Rnd() % 16 : TOKEN_BUFSIZE - 40 + Rnd() % 80);
+        tail = (int)(Rnd() % 12);
+        len = 0;
+        for (i = 0; i < body; ++i)   /* printable, with the odd interior blank */
+            data[len++] = (Rnd() % 20) ? (char)('!' + Rnd() % 94) : ws[Rnd() % 4];
+        for (i = 0; i < tail; ++i) data[len++] = ws[Rnd() % 4];
+        WriteHostFile(p, data, (size_t)len);
+
+        wl = len < TOKEN_BUFSIZE-1 ? len : TOKEN_BUFSIZE-1;
+        memcpy(want, data, (size_t)wl);
+        while (wl > 0 && strchr(ws, want[wl-1])) --wl;
+        want[wl] = 0;
+
+        n = ReadTokenFile(p, buf, sizeof(buf), &trunc);
+        if (n != wl || strcmp(buf, want) != 0 || trunc != (len > TOKEN_BUFSIZE-1)) {
+            CHECK(0, "token fuzz: result differs from model");
+            fprintf(stderr, "  round %d: len %d, got %ld/%d, want %d/%d\n", r, len, (long)n, trunc, wl, len > TOKEN_BUFSIZE-1);
+            break;
+        }
+        g_Checks++;
+    }
+}
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Reference pass: the same FGets/FWrite copy without any matching */
+static void RefCopy(void) {
+    char line[256];
+    BPTR in = Open(PATH_CLOUD_MOUNTLIST, MODE_OLDFILE);
+    BPTR out = Open(PATH_CLOUD_TMP, MODE_NEWFILE);
+    while (FGets(in, line, sizeof(line))) FWrite(out, line, (ULONG)strlen(line), 1);
+    Close(in); Close(out);
+    DeleteFile(PATH_CLOUD_TMP);
+}
+static void RewritePair(void) { Apply(1); Apply(0); }
+static void NoOp(void) { Apply(0); }
+static void Detect(void) { DetectMountlistVariant(); }
+
+/* Best of reps, in ms per MB */
+static double MsPerMB(void (*fn)(void), int reps, double mb) {
+    double best = 1e30, t;
+    int i;
+    for (i = 0; i < reps; ++i) {
+        t = Now(); fn(); t = Now() - t;
+        if (t < best) best = t;
+    }
+    return 1000.0 * best / mb;
+}
+
+/* Regression limits, relative to RefCopy on the same machine and run */
+#define BENCH_MAX_REWRITE  6.0   /* apply 1 + apply 0 (two passes) vs one copy */
+#define BENCH_MAX_NOOP     3.0
+#define BENCH_MAX_DETECT   2.0
+#define BENCH_MAX_SCALING  3.0   /* ms/MB at 20x entries vs 1x: catches O(n^2) */
+
+struct BenchResult { double copy, rewrite, noop, detect; };
+
+/* Time per MB of UpdateMountlistVariant (rewrite + no-op) and DetectMountlistVariant */
+static void Bench(int entries, int reps, struct BenchResult *r) {
+    struct Buf b = {0};
+    double mb;
+    MakeMountlist(&b, entries, 0, "\n");
+    SetMountlist(&b);
+    mb = (double)b.len / (1024.0*1024.0);
+
+    r->copy    = MsPerMB(RefCopy, reps, mb);
+    r->rewrite = MsPerMB(RewritePair, reps, mb);
+    CHECK(MountlistIs(b.p, b.len), "bench: file intact");
+    r->noop    = MsPerMB(NoOp, reps, mb);
+    r->detect  = MsPerMB(Detect, reps, mb);
+
+    printf("  %6d entries %5.2f MB: copy %6.2f  rewrite x2 %6.2f  no-op %6.2f  detect %6.2f ms/MB"
+           "  (rewrite %.0f MB/s)\n", entries, mb, r->copy, r->rewrite, r->noop, r->detect,
+           2000.0 / r->rewrite);
+
+    CHECK(r->rewrite <= BENCH_MAX_REWRITE * r->copy, "bench: rewrite slower than limit vs copy");
+    CHECK(r->noop    <= BENCH_MAX_NOOP    * r->copy, "bench: no-op slower than limit vs copy");
+    CHECK(r->detect  <= BENCH_MAX_DETECT  * r->copy, "bench: detect slower than limit vs copy");
+    BufFree(&b);
+}
+
+int main(void) {
+    strcpy(g_Dir, "/tmp/cloudcfg-test-XXXXXX");
+    if (!mkdtemp(g_Dir)) { perror("mkdtemp"); return 2; }
+    snprintf(g_MlPath, sizeof(g_MlPath), "%s/cloud.mountlist", g_Dir);
+    host_SetRoot(g_Dir);
+
+    RoundTrip("small LF", 2, "\n");
+    RoundTrip("small CRLF", 2, "\r\n");
+    RoundTrip("5000 entries LF", 5000, "\n");
+    RoundTrip("5000 entries CRLF", 5000, "\r\n");
+    TestPreserveLayout();
+    TestLongLines();
+    TestMissingHandlers();
+    TestFuzz(500);
+    TestTokens();
+    TestTokenFuzz(2000);
+
+    printf("time per MB:\n");
+    {
+        struct BenchResult small, big;
+        Bench(1000, 20, &small);
+        Bench(20000, 5, &big);
+        CHECK(big.rewrite <= BENCH_MAX_SCALING * small.rewrite, "bench: rewrite does not scale linearly");
+        CHECK(big.detect  <= BENCH_MAX_SCALING * small.detect,  "bench: detect does not scale linearly");
+    }
+
+    remove(g_MlPath);
+    {
+        char p[300];
+        snprintf(p, sizeof(p), "%s/token", g_Dir);
+        remove(p);
+    }
+    rmdir(g_Dir);
+
+    printf("%d checks, %d failed\n", g_Checks, g_Fails);
+    return g_Fails ? 1 : 0;
+}